@@ -1,10 +1,11 @@
 #include "chvi.hpp"
 
-#include <numeric>  // std::accumulate, std::partial_sum
-#include <chrono>   // std::this_thread::sleep_for
-#include <thread>   // std::this_thread::sleep_for
-#include <atomic>   // std::atomic
-#include <set>      // std::set
+#include <chrono>       // std::this_thread::sleep_for
+#include <thread>       // std::this_thread::sleep_for
+#include <atomic>       // std::atomic
+#include <algorithm>    // std::max, std::sort, std::unique
+#include <map>          // std::map
+#include <type_traits>  // std::is_same_v
 
 // fmt library
 #define FMT_HEADER_ONLY
@@ -16,6 +17,10 @@
 // modules
 #include "types.hpp"
 #include "convex_hull.hpp"
+#include "intern.hpp"
+#include "layout.hpp"
+#include "point.hpp"
+#include "telemetry.hpp"
 #include "log.hpp"
 
 #ifdef CYTHON
@@ -37,74 +42,226 @@
 // remove dominated points from convex hull
 constexpr bool PARTIAL = true;
 
+// rewards coming from the transition table of the environment are memoized by address
+#ifdef TRANSITION_TABLE
+typedef q_table<const coordinate *> memo_table;
+#else
+typedef q_table<coordinate> memo_table;
+#endif
+
 std::atomic<std::size_t> recomputed = 0;
 std::atomic<std::size_t> non_recomputed = 0;
+std::atomic<std::size_t> memo_hits = 0;
 
-auto state2id(const std::vector<coordinate> &state, const std::vector<std::size_t> &ex_pfx_product) {
+template<std::size_t D>
+auto Q(env_type env, const std::vector<std::size_t> &state_space_size, std::size_t action_space_size, const std::size_t id,
+       const std::vector<std::size_t> &ex_pfx_product, const std::vector<hull_handle> &hulls,
+       std::vector<hull_handle> &old_non_dominated, const double discount_factor,
+       hull_table &table, memo_table &memo, const std::size_t generation) {
 
-    std::size_t id = 0;
+    const auto dimensions = state_space_size.size();
+    memo_table::key key;
+    key.successors.reserve(action_space_size);
 
-    for (std::size_t dimension = 0; dimension < state.size(); ++dimension) {
-        id += state[dimension] * ex_pfx_product[dimension];
+    #ifdef TRANSITION_TABLE
+    (void) ex_pfx_product;
+    key.rewards.reserve(action_space_size);
+    for (std::size_t action = 0; action < action_space_size; ++action) {
+        key.successors.push_back(hulls[get_successor(env, id, action)].get());
+        key.rewards.push_back(get_reward(env, id, action));
     }
-
-    return id;
-}
-
-auto id2state(const std::size_t id, const std::vector<std::size_t> &ex_pfx_product, const std::vector<std::size_t> &state_space_size) {
-
-    std::vector<coordinate> state(state_space_size.size());
-
-    for (std::size_t dimension = 0; dimension < state_space_size.size(); ++dimension) {
-        state[dimension] = (id / ex_pfx_product[dimension]) % state_space_size[dimension];
+    #else
+    const auto state = id2state(id, ex_pfx_product, state_space_size);
+    key.rewards.reserve(action_space_size * dimensions);
+    for (std::size_t action = 0; action < action_space_size; ++action) {
+        const auto [ next_state, rewards ] = execute_action(env, state, action);
+        //fmt::print("Executed action {} on state {} (id: {}) -> new state: {} rewards: {}\n", action, state, id, next_state, rewards);
+        key.successors.push_back(hulls[state2id(next_state, ex_pfx_product)].get());
+        key.rewards.insert(std::end(key.rewards), std::begin(rewards), std::end(rewards));
     }
+    #endif
 
-    return state;
-}
-
-auto Q(env_type env, const std::vector<std::size_t> &state_space_size, std::size_t action_space_size, const std::size_t id,
-       const std::vector<std::size_t> &ex_pfx_product, const std::vector<std::vector<coordinate>> &hulls,
-       std::vector<std::vector<coordinate>> &old_non_dominated, const double discount_factor) {
+    // identical inputs yield identical outputs, skip the transformation and the convex hull entirely
+    const auto hash = key.hash();
+    if (const auto memoized = memo.find(key, hash, generation)) {
+        memo_hits++;
+        // the hull is no longer the one of old_non_dominated[id], force its recomputation on the next miss
+        old_non_dominated[id] = table.empty_hull();
+        return *memoized;
+    }
 
-    std::set<std::vector<coordinate>> unique;
-    const auto state = id2state(id, ex_pfx_product, state_space_size);
+    // each successor contributes one point for each vertex of its hull (or the origin, if its hull is empty)
+    std::size_t n_points = 0;
+    for (const auto successor : key.successors) {
+        n_points += std::max<std::size_t>(successor->size() / dimensions, 1);
+    }
+    std::vector<point<D>> unique;
+    unique.reserve(n_points);
 
     for (std::size_t action = 0; action < action_space_size; ++action) {
-        const auto [ next_state, rewards ] = execute_action(env, state, action);
-        //fmt::print("Executed action {} on state {} (id: {}) -> new state: {} rewards: {}\n", action, state, id, next_state, rewards);
-        const auto next_state_hull = hulls[state2id(next_state, ex_pfx_product)];
-        //fmt::print("hull {}\n", next_state_hull);
-        const auto transformed_hull = linear_transformation(next_state_hull, discount_factor, rewards);
-        //fmt::print("transformed {}\n", transformed_hull);
-        for (std::size_t i = 0; i < transformed_hull.size(); i += state.size()) {
-            unique.insert(std::vector<coordinate>(std::begin(transformed_hull) + i, std::begin(transformed_hull) + i + state.size()));
-        }
+        //fmt::print("hull {}\n", *key.successors[action]);
+        #ifdef TRANSITION_TABLE
+        const auto rewards = key.rewards[action];
+        #else
+        const auto rewards = &key.rewards[action * dimensions];
+        #endif
+        insert_linear_transformation(unique, *key.successors[action], discount_factor, rewards, dimensions);
     }
 
+    std::sort(std::begin(unique), std::end(unique));
+    unique.erase(std::unique(std::begin(unique), std::end(unique)), std::end(unique));
+
+    hull_handle hull;
+
     if (PARTIAL) {
-        const auto new_non_dominated = non_dominated(std::vector(std::begin(unique), std::end(unique)));
-        const auto flat_new_non_dominated = flatten(new_non_dominated);
-        if (flat_new_non_dominated == old_non_dominated[id]) {
+        const auto new_non_dominated = non_dominated(unique);
+        auto flat_new_non_dominated = flatten(new_non_dominated);
+        if (flat_new_non_dominated == *old_non_dominated[id]) {
             non_recomputed++;
-            return hulls[id];
+            hull = hulls[id];
         } else {
             recomputed++;
-            old_non_dominated[id] = std::move(flat_new_non_dominated);
-            return flatten(non_dominated(convex_hull(new_non_dominated)));
+            // interned as well, since it often coincides with the hull itself
+            old_non_dominated[id] = table.intern(std::move(flat_new_non_dominated));
+            hull = table.intern(flatten(non_dominated(convex_hull(new_non_dominated))));
         }
     } else {
-        return flatten(convex_hull(unique));
+        hull = table.intern(flatten(convex_hull(unique)));
     }
+
+    memo.insert(std::move(key), hash, hull, generation);
+    return hull;
 }
 
-std::vector<std::vector<coordinate>> run_chvi(env_type env, const double discount_factor, const std::size_t max_iterations,
-                                              const double epsilon, const bool verbose) {
+
+void set_telemetry(const double interval, const std::string &path) {
+
+    telemetry_config = { interval, path };
+}
+
+// state of the algorithm for a single (environment, discount factor, epsilon) configuration
+struct problem {
+    env_type env;
+    const layout &grid;
+    std::size_t action_space_size;
+    double discount_factor;
+    double epsilon;
+    // identical hulls are stored once in the table, states refer to them by means of handles
+    hull_table table;
+    // at most one entry for each state, i.e., as many as the ones which can be hit in the next sweep
+    memo_table memo;
+    // output of the algorithm, a vector of convex hulls (flat vector of coordinates), one for each state
+    std::vector<hull_handle> hulls;
+    // non-dominated points from which the hull of each state has been computed, interned like the hulls
+    std::vector<hull_handle> old_non_dominated;
+    std::vector<hull_handle> new_hulls;
+    std::size_t iterations = 0;
+    double delta = 0;
+    double previous_delta = 0;
+};
+
+auto make_problem(env_type env, const layout &grid, const double discount_factor, const double epsilon) {
+
+    problem p {
+        env, grid, get_action_space_size(env), discount_factor, epsilon, {}, memo_table(grid.n_states),
+        {}, {}, {}
+    };
+    p.hulls = std::vector<hull_handle>(grid.n_states, p.table.empty_hull());
+    p.old_non_dominated = p.hulls;
+
+    return p;
+}
+
+// compute the new hulls of the states assigned to the calling thread, returning their contribution to delta
+template<std::size_t D>
+auto update(problem &p, telemetry *monitor) {
+
+    const auto &grid = p.grid;
+    double delta = 0;
+    const auto thread = telemetry_thread();
+
+    // no barrier at the end, idle threads immediately move on to the next problem
+    #ifndef CYTHON
+    #pragma omp for schedule(dynamic, 64) nowait
+    #endif
+    for (std::size_t id = 0; id < grid.n_states; ++id) {
+        #ifdef TRANSITION_TABLE
+        const auto terminal = is_terminal_id(p.env, id);
+        #else
+        const auto terminal = is_terminal(p.env, id2state(id, grid.ex_pfx_product, grid.state_space_size));
+        #endif
+        if (!terminal) {
+            //fmt::print("ID: {} -> {}\n", id, id2state(id, grid.ex_pfx_product, grid.state_space_size));
+            p.new_hulls[id] = Q<D>(p.env, grid.state_space_size, p.action_space_size, id, grid.ex_pfx_product,
+                                   p.hulls, p.old_non_dominated, p.discount_factor, p.table, p.memo, p.iterations);
+            //fmt::print("Hull: {}\n", *p.new_hulls[id]);
+            delta += p.new_hulls[id]->size() / grid.state_space_size.size();
+        }
+        if (monitor) {
+            monitor->record(thread, terminal ? 0 : p.new_hulls[id]->size() / grid.state_space_size.size());
+        }
+    }
+
+    return delta;
+}
+
+// execute one iteration on each of the given problems, whose states are distributed over the same team of threads
+void sweep(const std::vector<problem *> &active, telemetry *monitor) {
+
+    std::size_t states = 0;
+    std::size_t iteration = 0;
+
+    for (auto p : active) {
+        p->new_hulls = std::vector<hull_handle>(p->grid.n_states, p->table.empty_hull());
+        p->delta = 0;
+        states += p->grid.n_states;
+        iteration = std::max(iteration, p->iterations + 1);
+    }
+
+    if (monitor) {
+        monitor->begin_sweep(iteration, states);
+    }
+
+    #ifndef CYTHON
+    #pragma omp parallel
+    #endif
+    for (auto p : active) {
+        const auto delta = dispatch_dimensions(p->grid.state_space_size.size(), [p, monitor]<std::size_t D>() { return update<D>(*p, monitor); });
+        #ifndef CYTHON
+        #pragma omp atomic
+        #endif
+        p->delta += delta;
+    }
+
+    for (auto p : active) {
+        p->hulls = std::move(p->new_hulls);
+        p->memo.purge(p->hulls, p->iterations);
+        p->table.purge();
+        p->iterations++;
+    }
+}
+
+// copy the interned hulls in the output format of the list interface
+auto expand(const std::vector<hull_handle> &hulls) {
+
+    std::vector<std::vector<coordinate>> expanded(hulls.size());
+    std::transform(std::begin(hulls), std::end(hulls), std::begin(expanded), [](const auto &h) { return *h; });
+
+    return expanded;
+}
+
+auto relative_difference(const problem &p) {
+
+    return std::abs(p.delta - p.previous_delta) / p.grid.n_states;
+}
+
+// solve a single problem, returning the interned hull of each state
+auto solve(env_type env, const double discount_factor, const std::size_t max_iterations, const double epsilon, const bool verbose) {
 
     auto start = std::chrono::system_clock::now();
-    const auto state_space_size = get_observation_space_size(env);
-    const auto n_states = std::accumulate(std::begin(state_space_size), std::end(state_space_size), 1ULL, std::multiplies<>());
+    const auto grid = make_layout(get_observation_space_size(env));
     const auto n_goals = get_n_goals(env);
-    const auto action_space_size = get_action_space_size(env);
+    auto p = make_problem(env, grid, discount_factor, epsilon);
 
     if (verbose) {
         log_line();
@@ -113,9 +270,9 @@ std::vector<std::vector<coordinate>> run_chvi(env_type env, const double discoun
         log_line();
         log_title("Environment Statistics");
         log_line();
-        log_string("State space size", fmt::format("{} ({} states)", state_space_size, n_states));
-        log_string("Number of goal states", fmt::format("{} ({:.2f}%)", n_goals, 100.0 * n_goals / n_states));
-        log_fmt("Action space size", action_space_size);
+        log_string("State space size", fmt::format("{} ({} states)", grid.state_space_size, grid.n_states));
+        log_string("Number of goal states", fmt::format("{} ({:.2f}%)", n_goals, 100.0 * n_goals / grid.n_states));
+        log_fmt("Action space size", p.action_space_size);
         log_line();
         log_title("Algorithm Parameters");
         log_line();
@@ -129,23 +286,11 @@ std::vector<std::vector<coordinate>> run_chvi(env_type env, const double discoun
         log_line();
     }
 
-    // data structure useful to associate each thread to a vector state
-    std::vector<std::size_t> ex_pfx_product(state_space_size.size(), 1ULL);
-    std::partial_sum(std::begin(state_space_size), std::end(state_space_size) - 1, std::begin(ex_pfx_product) + 1, std::multiplies<>());
-
-    // output of the algorithm, a vector of convex hulls (flat vector of coordinates), one for each state
-    std::vector<std::vector<coordinate>> hulls(n_states);
-    //fmt::print("Initial hulls: {}\n", hulls);
-    std::vector<std::vector<coordinate>> old_non_dominated(n_states);
-
     if (verbose) {
         log_title("Relative Difference");
         log_line();
     }
 
-    std::size_t iteration = 0;
-    double previous_delta = 0;
-
     #ifdef CPU_PROFILER
     ProfilerStart(CPU_PROFILER_OUTPUT);
     #endif
@@ -154,39 +299,24 @@ std::vector<std::vector<coordinate>> run_chvi(env_type env, const double discoun
     HeapProfilerStart(HEAP_PROFILER_PREFIX);
     #endif
 
-    while (++iteration <= max_iterations) {
-        double delta = 0;
-        std::vector<std::vector<coordinate>> new_hulls(n_states);
-        #ifndef CYTHON
-        #pragma omp parallel for reduction(+:delta)
-        #endif
-        for (std::size_t id = 0; id < n_states; ++id) {
-            if (!is_terminal(env, id2state(id, ex_pfx_product, state_space_size))) {
-                //fmt::print("ID: {} -> {}\n", id, id2state(id, ex_pfx_product, state_space_size));
-                new_hulls[id] = Q(env, state_space_size, action_space_size, id, ex_pfx_product, hulls, old_non_dominated, discount_factor);
-                //fmt::print("Hull: {}\n", new_hulls[id]);
-                delta += new_hulls[id].size() / state_space_size.size();
-            }
-        }
-        hulls = std::move(new_hulls);
+    const auto monitor = make_telemetry();
+
+    while (p.iterations < max_iterations) {
+        sweep({ &p }, monitor.get());
         if (verbose) {
-            log_string(fmt::format("Iteration {}", iteration), fmt::format("{:.5f} ({})", std::abs(delta - previous_delta) / n_states, delta));
+            log_string(fmt::format("Iteration {}", p.iterations), fmt::format("{:.5f} ({})", relative_difference(p), p.delta));
         }
-        if (std::abs(delta - previous_delta) / n_states <= epsilon) {
+        if (relative_difference(p) <= epsilon) {
             break;
         }
-        previous_delta = delta;
+        p.previous_delta = p.delta;
         #ifdef HEAP_PROFILER
-        auto memory_a = sizeof(hulls);
-        auto memory_b = 0ULL;
-        for (auto hull : hulls) {
-            memory_a += sizeof(hull);
-            memory_a += hull.size() * sizeof(coordinate);
-            memory_b += hull.size() * sizeof(coordinate);
-        }
+        auto memory_a = sizeof(p.hulls) + p.hulls.size() * sizeof(hull_handle);
+        auto memory_b = p.table.coordinates() * sizeof(coordinate);
+        memory_a += p.table.size() * sizeof(std::vector<coordinate>) + memory_b;
         #define MB(X) ((1.0f * (X)) / (1024 * 1024))
         fmt::print("Memory (total, points): {:.1f} MB, {:.1f} MB\n", MB(memory_a), MB(memory_b));
-        HeapProfilerDump(fmt::format("Iteration {}", iteration).c_str());
+        HeapProfilerDump(fmt::format("Iteration {}", p.iterations).c_str());
         #endif
     }
 
@@ -202,13 +332,147 @@ std::vector<std::vector<coordinate>> run_chvi(env_type env, const double discoun
         log_line();
         log_title("Algorithm Statistics");
         log_line();
-        log_fmt("Executed iterations", std::min(iteration, max_iterations));
+        log_fmt("Executed iterations", p.iterations);
         log_fmt("Avoided convex hull recomputations", fmt::format("{}/{} ({:.2f}%)",
             non_recomputed, recomputed + non_recomputed, 100.0 * non_recomputed / (recomputed + non_recomputed))
         );
+        log_fmt("Memoized Q computations", fmt::format("{}/{} ({:.2f}%)",
+            memo_hits, memo_hits + recomputed + non_recomputed, 100.0 * memo_hits / (memo_hits + recomputed + non_recomputed))
+        );
+        log_string("Distinct non-empty point sets", fmt::format("{} ({} states)", p.table.size(), grid.n_states));
         log_string("Runtime", fmt::format("{:%T}", std::chrono::system_clock::now() - start));
         log_line();
     }
 
-    return hulls;
+    // the tables are released with the problem, the handles keep alive the hulls of the states
+    return std::move(p.hulls);
+}
+
+std::vector<std::vector<coordinate>> run_chvi(env_type env, const double discount_factor, const std::size_t max_iterations,
+                                              const double epsilon, const bool verbose) {
+
+    return expand(solve(env, discount_factor, max_iterations, epsilon, verbose));
+}
+
+// concatenate either plain or interned hulls, releasing each of them (i.e., a reference, in case of interned hulls) as soon
+// as it has been copied, so that the peak memory usage stays close to the one of the output
+template<typename H>
+void concatenate(std::vector<H> &&hulls, const std::size_t dimensions, std::vector<std::size_t> &offsets, std::vector<coordinate> &points) {
+
+    auto coordinates = [](const H &h) -> const std::vector<coordinate> & {
+        if constexpr (std::is_same_v<H, hull_handle>) {
+            return *h;
+        } else {
+            return h;
+        }
+    };
+
+    offsets.resize(hulls.size() + 1);
+    offsets[0] = 0;
+    for (std::size_t id = 0; id < hulls.size(); ++id) {
+        offsets[id + 1] = offsets[id] + coordinates(hulls[id]).size() / dimensions;
+    }
+
+    points.clear();
+    points.reserve(offsets.back() * dimensions);
+    for (auto &hull : hulls) {
+        points.insert(std::end(points), std::begin(coordinates(hull)), std::end(coordinates(hull)));
+        H().swap(hull);
+    }
+}
+
+void to_csr(std::vector<std::vector<coordinate>> &&hulls, const std::size_t dimensions,
+            std::vector<std::size_t> &offsets, std::vector<coordinate> &points) {
+
+    concatenate(std::move(hulls), dimensions, offsets, points);
+}
+
+void run_chvi_csr(env_type env, const double discount_factor, const std::size_t max_iterations, const double epsilon, const bool verbose,
+                  std::vector<std::size_t> &offsets, std::vector<coordinate> &points) {
+
+    // the hulls are copied once, straight from the interned ones
+    const auto dimensions = get_observation_space_size(env).size();
+    concatenate(solve(env, discount_factor, max_iterations, epsilon, verbose), dimensions, offsets, points);
+}
+
+std::vector<std::vector<std::vector<coordinate>>> run_chvi_batch(const std::vector<instance> &instances,
+                                                                 const std::size_t max_iterations, const bool verbose) {
+
+    auto start = std::chrono::system_clock::now();
+
+    // instances defined over the same state space share the same layout
+    std::map<std::vector<std::size_t>, layout> layouts;
+    std::vector<problem> problems;
+    problems.reserve(instances.size());
+
+    for (const auto &instance : instances) {
+        const auto state_space_size = get_observation_space_size(instance.env);
+        const auto [ it, inserted ] = layouts.try_emplace(state_space_size, make_layout(state_space_size));
+        (void) inserted;
+        problems.push_back(make_problem(instance.env, it->second, instance.discount_factor, instance.epsilon));
+    }
+
+    if (verbose) {
+        log_line();
+        log_title("Convex Hull Value Iteration (Batch)");
+        log_title("https://github.com/filippobistaffa/chvi");
+        log_line();
+        log_title("Batch Parameters");
+        log_line();
+        log_fmt("Number of instances", instances.size());
+        log_fmt("Distinct state spaces", layouts.size());
+        log_fmt("Maximum number of iterations", max_iterations);
+        log_string("Precision", fmt::format("{} bits", sizeof(coordinate) * 8));
+        #ifndef CYTHON
+        log_fmt("Available parallel threads", omp_get_max_threads());
+        #endif
+        log_line();
+        log_title("Convergence");
+        log_line();
+    }
+
+    std::vector<problem *> active(problems.size());
+    std::transform(std::begin(problems), std::end(problems), std::begin(active), [](auto &p) { return &p; });
+
+    #ifdef CPU_PROFILER
+    ProfilerStart(CPU_PROFILER_OUTPUT);
+    #endif
+
+    const auto monitor = make_telemetry();
+
+    for (std::size_t iteration = 0; iteration < max_iterations && !active.empty(); ++iteration) {
+        sweep(active, monitor.get());
+        std::erase_if(active, [&](auto p) {
+            const auto converged = relative_difference(*p) <= p->epsilon;
+            if (verbose && (converged || p->iterations == max_iterations)) {
+                log_string(fmt::format("Instance {} (f = {}, e = {})", p - problems.data(), p->discount_factor, p->epsilon),
+                           fmt::format("{} after {} iterations ({})", converged ? "converged" : "stopped", p->iterations, p->delta));
+            }
+            p->previous_delta = p->delta;
+            return converged;
+        });
+    }
+
+    #ifdef CPU_PROFILER
+    ProfilerStop();
+    #endif
+
+    if (verbose) {
+        log_line();
+        log_title("Algorithm Statistics");
+        log_line();
+        log_fmt("Avoided convex hull recomputations", fmt::format("{}/{} ({:.2f}%)",
+            non_recomputed, recomputed + non_recomputed, 100.0 * non_recomputed / (recomputed + non_recomputed))
+        );
+        log_fmt("Memoized Q computations", fmt::format("{}/{} ({:.2f}%)",
+            memo_hits, memo_hits + recomputed + non_recomputed, 100.0 * memo_hits / (memo_hits + recomputed + non_recomputed))
+        );
+        log_string("Runtime", fmt::format("{:%T}", std::chrono::system_clock::now() - start));
+        log_line();
+    }
+
+    std::vector<std::vector<std::vector<coordinate>>> results(problems.size());
+    std::transform(std::begin(problems), std::end(problems), std::begin(results), [](const auto &p) { return expand(p.hulls); });
+
+    return results;
 }
@@ -3,6 +3,7 @@
 
 #include "types.hpp" // coordinate type
 #include <vector>    // std::vector
+#include <string>    // std::string
 
 #ifdef CYTHON
 
@@ -40,8 +41,55 @@ inline auto is_terminal(env_type env, std::vector<coordinate> state) {
     return env.is_terminal(state);
 }
 
+// the native environment precomputes its transitions, which the algorithms can directly query by state id
+#define TRANSITION_TABLE
+
+inline auto is_terminal_id(env_type env, const std::size_t id) {
+
+    return env.is_terminal(id);
+}
+
+inline auto get_successor(env_type env, const std::size_t id, const std::size_t action) {
+
+    return env.successor(id, action);
+}
+
+inline auto get_reward(env_type env, const std::size_t id, const std::size_t action) {
+
+    return env.reward(id, action);
+}
+
 #endif
 
+// one configuration of a batch run, several instances can refer to the same environment
+struct instance {
+    env_type env;
+    double discount_factor;
+    double epsilon;
+};
+
 std::vector<std::vector<coordinate>> run_chvi(env_type env, const double discount_factor, const std::size_t max_iterations, const double epsilon = 0, const bool verbose = true);
 
+// same as run_chvi, but the hulls are returned in a CSR-like format: the points (rows of dimensions coordinates)
+// of the hull of the i-th state are the rows in the [offsets[i], offsets[i + 1]) range of points
+void run_chvi_csr(env_type env, const double discount_factor, const std::size_t max_iterations, const double epsilon, const bool verbose,
+                  std::vector<std::size_t> &offsets, std::vector<coordinate> &points);
+
+// concatenate the hulls in the CSR-like format described above, releasing each of them once copied
+void to_csr(std::vector<std::vector<coordinate>> &&hulls, const std::size_t dimensions, std::vector<std::size_t> &offsets, std::vector<coordinate> &points);
+
+// alternative engine based on optimistic linear support, which only builds the convex coverage set of the initial
+// state by solving scalarised problems for its corner weights, instead of computing full convex hulls
+// the output has one entry per state as in run_chvi, but only the first one (the initial state) is filled, all the
+// others are empty since the corner weights of the initial state do not yield the coverage sets of the other states
+std::vector<std::vector<coordinate>> run_ols(env_type env, const double discount_factor, const std::size_t max_iterations, const double epsilon = 0, const bool verbose = true);
+
+void run_ols_csr(env_type env, const double discount_factor, const std::size_t max_iterations, const double epsilon, const bool verbose,
+                 std::vector<std::size_t> &offsets, std::vector<coordinate> &points);
+
+// periodically report the progress of the solvers (every interval seconds, disabled if 0) to the given file, or to stderr if empty
+void set_telemetry(const double interval, const std::string &path);
+
+std::vector<std::vector<std::vector<coordinate>>> run_chvi_batch(const std::vector<instance> &instances, const std::size_t max_iterations, const bool verbose = true);
+
 #endif
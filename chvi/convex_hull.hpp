@@ -2,51 +2,43 @@
 #define CONVEX_HULL_HPP_
 
 #include "types.hpp"                    // coordinate type
+#include "point.hpp"                    // point type
 #include <set>                          // std::set
-#include <algorithm>                    // std::transform
+#include <algorithm>                    // std::transform, std::minmax_element
+#include <numeric>                      // std::inner_product
+#include <cmath>                        // std::sqrt, std::abs
+#include <type_traits>                  // std::decay_t
 #include <libqhullcpp/Qhull.h>          // qhull library
 #include <libqhullcpp/QhullFacetList.h> // qhull library
 #include <libqhullcpp/QhullVertexSet.h> // qhull library
 #include "pagmo.hpp"                    // code extracted from pagmo library
 
-auto scale_coordinates(const std::vector<coordinate> &coordinates, const double gamma) {
+// append the points of the (flat) hull, scaled by gamma and translated by delta, to the given vector of points,
+// an empty hull is considered as the origin
+template<typename P>
+inline void insert_linear_transformation(std::vector<P> &points, const std::vector<coordinate> &coordinates, const double gamma,
+                                         const coordinate *delta, const std::size_t dimensions) {
 
-    std::vector<coordinate> scaled(coordinates.size());
-
-    for (std::size_t c = 0; c < coordinates.size(); ++c) {
-        scaled[c] = coordinates[c] * gamma;
+    if (coordinates.size() == 0) {
+        points.push_back(make_point<P>(delta, dimensions));
+        return;
     }
 
-    return scaled;
-}
-
-auto transpose_coordinates(const std::vector<coordinate> &coordinates, const std::vector<coordinate> &delta) {
-
-    std::vector<coordinate> transposed(coordinates.size());
-
-    for (std::size_t p = 0; p < coordinates.size() / delta.size(); ++p) {
-        for (std::size_t c = 0; c < delta.size(); ++c) {
-            transposed[p * delta.size() + c] = coordinates[p * delta.size() + c] + delta[c];
+    for (std::size_t i = 0; i < coordinates.size(); i += dimensions) {
+        auto p = make_point<P>(dimensions);
+        for (std::size_t c = 0; c < p.size(); ++c) {
+            p[c] = (coordinate)(coordinates[i + c] * gamma) + delta[c];
         }
+        points.push_back(std::move(p));
     }
-
-    return transposed;
-}
-
-auto linear_transformation(const std::vector<coordinate> &coordinates, const double gamma, const std::vector<coordinate> &delta) {
-
-    if (coordinates.size() == 0) {
-        return std::vector<coordinate>(delta);
-    }
-
-    return transpose_coordinates(scale_coordinates(coordinates, gamma), delta);
 }
 
-auto non_dominated(const std::vector<std::vector<coordinate>> &points) {
+template<typename P>
+inline auto non_dominated(const std::vector<P> &points) {
 
     // check for empty input set of points
     if (points.size() <= 1) {
-        return std::vector<std::vector<coordinate>>(points);
+        return std::vector<P>(points);
     }
 
     // https://esa.github.io/pagmo2/docs/cpp/utils/multi_objective.html#namespacepagmo_1a27aeb5efb01fca4422fc124eec221199
@@ -61,7 +53,7 @@ auto non_dominated(const std::vector<std::vector<coordinate>> &points) {
 
     // compile output
     const auto pareto = non_dom_fronts.front(); // containts points' indices with respect to input
-    std::vector<std::vector<coordinate>> non_dominated(pareto.size());
+    std::vector<P> non_dominated(pareto.size());
     std::transform(std::begin(pareto), std::end(pareto), std::begin(non_dominated), [&points](const auto &i) {
         return points[i];
     });
@@ -69,7 +61,8 @@ auto non_dominated(const std::vector<std::vector<coordinate>> &points) {
     return non_dominated;
 }
 
-auto flatten(const std::vector<std::vector<coordinate>> &points) {
+template<typename P>
+inline auto flatten(const std::vector<P> &points) {
 
     const auto dimensions = points.front().size();
     std::vector<coordinate> flat(points.size() * dimensions);
@@ -81,10 +74,73 @@ auto flatten(const std::vector<std::vector<coordinate>> &points) {
     return flat;
 }
 
+// relative tolerance below which a direction is considered to be spanned by the affine basis
+constexpr double AFFINE_TOLERANCE = 1e-6;
+
+// orthonormal basis of the affine hull of the points (translated to the first point), computed by Gram-Schmidt
+template<typename P>
+inline auto affine_basis(const std::vector<const P *> &points) {
+
+    typedef point<static_dimensions<P>, double> direction;
+    const auto dimensions = points.front()->size();
+    const auto &origin = *points.front();
+    std::vector<direction> basis;
+
+    // scale of the input, used to make the tolerance relative
+    double scale = 0;
+    for (const auto p : points) {
+        for (std::size_t c = 0; c < dimensions; ++c) {
+            scale = std::max(scale, std::abs((double)(*p)[c] - origin[c]));
+        }
+    }
+
+    for (const auto p : points) {
+        if (basis.size() == dimensions) {
+            break;
+        }
+        auto residual = make_point<direction>(dimensions);
+        for (std::size_t c = 0; c < dimensions; ++c) {
+            residual[c] = (double)(*p)[c] - origin[c];
+        }
+        for (const auto &b : basis) {
+            const auto dot = std::inner_product(std::begin(residual), std::end(residual), std::begin(b), 0.0);
+            for (std::size_t c = 0; c < dimensions; ++c) {
+                residual[c] -= dot * b[c];
+            }
+        }
+        const auto norm = std::sqrt(std::inner_product(std::begin(residual), std::end(residual), std::begin(residual), 0.0));
+        if (norm > AFFINE_TOLERANCE * scale) {
+            std::transform(std::begin(residual), std::end(residual), std::begin(residual), [norm](double r) { return r / norm; });
+            basis.push_back(std::move(residual));
+        }
+    }
+
+    return basis;
+}
+
+// indices of the input points which are vertices of their convex hull, computed by qhull
+inline auto qhull_vertices(const std::vector<double> &coordinates, const std::size_t dimensions) {
+
+    orgQhull::Qhull qhull;
+    qhull.runQhull("", dimensions, coordinates.size() / dimensions, coordinates.data(), "Qx Qt");
+
+    // iterate over all facets and, for each facet, over all vertices
+    // maintain unique occurrences by means of a set data structure
+    std::set<std::size_t> vertices;
+    for (const auto &facet : qhull.facetList()) {
+        for (const auto &vertex : facet.vertices()) {
+            vertices.insert(vertex.point().id());
+        }
+    }
+
+    return vertices;
+}
+
 template<typename T>
 auto convex_hull(const T &points) {
 
-    std::vector<std::vector<coordinate>> convex_hull;
+    typedef std::decay_t<decltype(*std::begin(points))> P;
+    std::vector<P> convex_hull;
 
     // check for empty input set of points
     if (points.size() == 0) {
@@ -94,37 +150,80 @@ auto convex_hull(const T &points) {
     // compute number of dimensions
     const auto dimensions = std::begin(points)->size();
 
-    // compile input for qhull (double type required by runQhull)
-    std::vector<double> coordinates;
+    // random access to the input points, regardless of the input container
+    std::vector<const P *> input;
+    input.reserve(points.size());
     for (const auto &p : points) {
-        coordinates.insert(std::end(coordinates), std::begin(p), std::end(p));
+        input.push_back(&p);
     }
 
-    try {
+    // degenerate inputs (e.g., collinear or coplanar points) lie in a proper affine subspace, in which case the
+    // hull is computed on the coordinates of the points with respect to a basis of such subspace and then lifted
+    // back by picking the corresponding input points
+    const auto basis = affine_basis(input);
+    const auto &origin = *input.front();
+    std::set<P> unique;
+
+    if (basis.size() == 0) {
 
-        // try to compute convex hull
-        orgQhull::Qhull qhull;
-        qhull.runQhull("", dimensions, points.size(), coordinates.data(), "Qx Qt");
+        // all points coincide
+        unique.insert(origin);
 
-        // iterate over all facets and, for each facet, over all vertices
-        // maintain unique occurrences by means of a set data structure
-        std::set<std::vector<coordinate>> unique;
-        for (const auto &facet : qhull.facetList()) {
-            for (const auto &vertex : facet.vertices()) {
-                const double *coordinates = vertex.point().coordinates();
-                std::vector<coordinate> p(coordinates, coordinates + dimensions);
-                unique.insert(p);
+    } else if (basis.size() == 1) {
+
+        // all points are collinear, the hull is made of the two extremes of the segment
+        auto projection = [&](const auto p) {
+            double t = 0;
+            for (std::size_t c = 0; c < dimensions; ++c) {
+                t += ((double)(*p)[c] - origin[c]) * basis.front()[c];
+            }
+            return t;
+        };
+        const auto [ min, max ] = std::minmax_element(std::begin(input), std::end(input), [&](const auto a, const auto b) {
+            return projection(a) < projection(b);
+        });
+        unique.insert(**min);
+        unique.insert(**max);
+
+    } else {
+
+        // compile input for qhull (double type required by runQhull)
+        std::vector<double> coordinates;
+        coordinates.reserve(input.size() * basis.size());
+        if (basis.size() == dimensions) {
+            for (const auto p : input) {
+                coordinates.insert(std::end(coordinates), std::begin(*p), std::end(*p));
+            }
+        } else {
+            for (const auto p : input) {
+                for (const auto &b : basis) {
+                    double t = 0;
+                    for (std::size_t c = 0; c < dimensions; ++c) {
+                        t += ((double)(*p)[c] - origin[c]) * b[c];
+                    }
+                    coordinates.push_back(t);
+                }
             }
         }
-        convex_hull.reserve(unique.size());
-        convex_hull.assign(std::begin(unique), std::end(unique));
 
-    } catch (orgQhull::QhullError &e) {
+        try {
 
-        // in case of error return the input set of points
-        convex_hull.insert(std::end(convex_hull), std::begin(points), std::end(points));
+            // try to compute convex hull
+            for (const auto v : qhull_vertices(coordinates, basis.size())) {
+                unique.insert(*input[v]);
+            }
+
+        } catch (orgQhull::QhullError &e) {
+
+            // in case of error return the input set of points
+            convex_hull.insert(std::end(convex_hull), std::begin(points), std::end(points));
+            return convex_hull;
+        }
     }
 
+    convex_hull.reserve(unique.size());
+    convex_hull.assign(std::begin(unique), std::end(unique));
+
     return convex_hull;
 }
 
@@ -2,10 +2,15 @@
 #define ENV_HPP_
 
 #include <set>          // std::set
+#include <map>          // std::map
+#include <memory>       // std::shared_ptr, std::weak_ptr
+#include <mutex>        // std::mutex, std::lock_guard
+#include <utility>      // std::pair
 #include <tuple>        // std::make_tuple
 #include <vector>       // std::vector
 #include <cmath>        // std::pow
 #include "types.hpp"    // std::vector, coordinate type
+#include "layout.hpp"   // state2id
 #include "pgc.hpp"      // pseudo-random number generator
 
 // fmt library
@@ -13,11 +18,73 @@
 #include <fmt/core.h>
 #include <fmt/ranges.h>
 
+// transitions of a grid, which only depend on its number of dimensions and on its size, hence they are shared by
+// all the environments defined over the same grid regardless of their seed (i.e., of their goals)
+struct grid_transitions {
+    layout grid;
+    // successor of each (state, action) pair, indexed by state id, and the rewards of the 2 * dimensions possible
+    // (moved dimension, terminal successor) combinations
+    std::vector<std::size_t> successors;
+    std::vector<std::vector<coordinate>> rewards;
+};
+
+inline auto make_grid_transitions(const std::size_t dimensions, const std::size_t size) {
+
+    const auto action_space_size = 2 * dimensions;
+    auto t = std::make_shared<grid_transitions>();
+    t->grid = make_layout(std::vector<std::size_t>(dimensions, size));
+
+    t->rewards = std::vector<std::vector<coordinate>>(2 * dimensions);
+    for (std::size_t dimension = 0; dimension < dimensions; ++dimension) {
+        for (const bool goal : { false, true }) {
+            std::vector<coordinate> rw(dimensions, goal ? (coordinate)size : 0);
+            rw[dimension] -= 1;
+            t->rewards[2 * dimension + goal] = std::move(rw);
+        }
+    }
+
+    t->successors = std::vector<std::size_t>(t->grid.n_states * action_space_size);
+    for (std::size_t id = 0; id < t->grid.n_states; ++id) {
+        for (std::size_t action = 0; action < action_space_size; ++action) {
+            const auto dimension = action / 2;
+            const auto position = (id / t->grid.ex_pfx_product[dimension]) % size;
+            auto next = id;
+            if (action % 2 == 1 && position < size - 1) {
+                next += t->grid.ex_pfx_product[dimension];
+            } else if (action % 2 == 0 && position > 0) {
+                next -= t->grid.ex_pfx_product[dimension];
+            }
+            t->successors[id * action_space_size + action] = next;
+        }
+    }
+
+    return std::shared_ptr<const grid_transitions>(std::move(t));
+}
+
+// return the transitions of the given grid, built only if no other environment currently refers to them
+inline auto shared_grid_transitions(const std::size_t dimensions, const std::size_t size) {
+
+    static std::mutex mutex;
+    static std::map<std::pair<std::size_t, std::size_t>, std::weak_ptr<const grid_transitions>> cache;
+
+    std::lock_guard<std::mutex> lock(mutex);
+    auto &cached = cache[{ dimensions, size }];
+    auto t = cached.lock();
+    if (!t) {
+        t = make_grid_transitions(dimensions, size);
+        cached = t;
+    }
+
+    return t;
+}
+
 class Env {
 
     std::size_t dimensions;
     std::size_t size;
-    std::set<std::vector<coordinate>> goals;
+    std::shared_ptr<const grid_transitions> transitions;
+    // terminal states indexed by state id, the only part of the transitions depending on the seed
+    std::vector<bool> terminal;
 
   public:
     std::vector<std::size_t> state_space_size;
@@ -26,11 +93,12 @@ class Env {
     std::size_t seed;
 
     Env(std::size_t dimensions, std::size_t size, std::size_t seed):
-        dimensions(dimensions), size(size), seed(seed) {
+        dimensions(dimensions), size(size), transitions(shared_grid_transitions(dimensions, size)), seed(seed) {
 
             state_space_size = std::vector<std::size_t>(dimensions, size);
             action_space_size = 2 * dimensions;
             n_goals = std::max(1.0, std::round(0.2 * std::pow(size, dimensions - 1)));
+            std::set<std::vector<coordinate>> goals;
             // use our 64-bit seed to get 2 32-bit seeds needed by this PRNG
             const uint32_t upper_seed = seed >> 32;
             const uint32_t lower_seed = seed;
@@ -53,26 +121,43 @@ class Env {
             }
             //fmt::print("{}\n", n_goals);
             //fmt::print("{}\n", goals);
-        }
 
-    auto execute_action(std::vector<coordinate> state, std::size_t action) {
-
-        const auto dimension = action / 2;
-        const auto step = (coordinate)2.0 * (action % 2) - 1;
-        state[dimension] = std::clamp(state[dimension] + step, (coordinate)0.0, (coordinate)size - 1);
-        std::vector<coordinate> rw(state.size(), 0);
-        rw[dimension] = -1;
-        if (is_terminal(state)) {
-            for (std::size_t i = 0; i < rw.size(); ++i) {
-                rw[i] += size;
+            terminal = std::vector<bool>(transitions->grid.n_states);
+            for (const auto &goal : goals) {
+                terminal[state2id(goal, transitions->grid.ex_pfx_product)] = true;
             }
         }
-        return std::make_tuple(state, rw);
+
+    auto execute_action(const std::vector<coordinate> &state, std::size_t action) const {
+
+        const auto id = state2id(state, transitions->grid.ex_pfx_product);
+        const auto next = successor(id, action);
+        auto next_state = state;
+        next_state[action / 2] = (next / transitions->grid.ex_pfx_product[action / 2]) % size;
+        const auto rw = reward(id, action);
+        return std::make_tuple(next_state, std::vector<coordinate>(rw, rw + dimensions));
+    }
+
+    bool is_terminal(const std::vector<coordinate> &state) const {
+
+        return terminal[state2id(state, transitions->grid.ex_pfx_product)];
+    }
+
+    // fast path on state ids, which does not allocate any vector
+
+    bool is_terminal(const std::size_t id) const {
+
+        return terminal[id];
+    }
+
+    std::size_t successor(const std::size_t id, const std::size_t action) const {
+
+        return transitions->successors[id * action_space_size + action];
     }
 
-    bool is_terminal(std::vector<coordinate> state) {
+    const coordinate *reward(const std::size_t id, const std::size_t action) const {
 
-        return (goals.contains(state));
+        return transitions->rewards[2 * (action / 2) + terminal[successor(id, action)]].data();
     }
 };
 
@@ -0,0 +1,230 @@
+#ifndef INTERN_HPP_
+#define INTERN_HPP_
+
+#include "types.hpp"        // coordinate type
+#include <algorithm>        // std::any_of
+#include <functional>       // std::hash
+#include <memory>           // std::shared_ptr, std::unique_ptr
+#include <mutex>            // std::mutex, std::lock_guard
+#include <optional>         // std::optional
+#include <unordered_map>    // std::unordered_multimap
+#include <unordered_set>    // std::unordered_set
+#include <utility>          // std::declval, std::pair
+#include <vector>           // std::vector
+
+// hulls are immutable once computed, identical hulls are shared by means of reference counted handles
+typedef std::shared_ptr<const std::vector<coordinate>> hull_handle;
+
+inline void hash_combine(std::size_t &seed, const std::size_t hash) {
+
+    seed ^= hash + 0x9e3779b97f4a7c15ULL + (seed << 6) + (seed >> 2);
+}
+
+inline auto hash_coordinates(const std::vector<coordinate> &coordinates, std::size_t seed = 0) {
+
+    for (const auto c : coordinates) {
+        hash_combine(seed, std::hash<coordinate>{}(c));
+    }
+
+    return seed;
+}
+
+// hash table split in independently locked shards, so that concurrent accesses rarely contend for the same lock
+template<typename T>
+class concurrent_table {
+
+    static constexpr std::size_t SHARDS = 64;
+
+    struct shard {
+        std::mutex mutex;
+        std::unordered_multimap<std::size_t, T> entries;
+    };
+
+    std::unique_ptr<shard[]> shards;
+
+  public:
+    concurrent_table(): shards(std::make_unique<shard[]>(SHARDS)) {}
+
+    // return the first value with the given hash satisfying the predicate, or insert the one built by the factory
+    template<typename P, typename F>
+    T find_or_insert(const std::size_t hash, P predicate, F factory) {
+
+        auto &s = shards[hash % SHARDS];
+        std::lock_guard<std::mutex> lock(s.mutex);
+        const auto [ begin, end ] = s.entries.equal_range(hash);
+        for (auto it = begin; it != end; ++it) {
+            if (predicate(it->second)) {
+                return it->second;
+            }
+        }
+        return s.entries.emplace(hash, factory())->second;
+    }
+
+    // return the projection of the first value with the given hash satisfying the predicate, if any
+    template<typename P, typename G>
+    auto find(const std::size_t hash, P predicate, G projection) -> std::optional<decltype(projection(std::declval<T &>()))> {
+
+        auto &s = shards[hash % SHARDS];
+        std::lock_guard<std::mutex> lock(s.mutex);
+        const auto [ begin, end ] = s.entries.equal_range(hash);
+        for (auto it = begin; it != end; ++it) {
+            if (predicate(it->second)) {
+                return projection(it->second);
+            }
+        }
+        return std::nullopt;
+    }
+
+    // the value is not inserted if its shard already holds its share of the given capacity
+    void insert(const std::size_t hash, T &&value, const std::size_t capacity) {
+
+        auto &s = shards[hash % SHARDS];
+        std::lock_guard<std::mutex> lock(s.mutex);
+        if (s.entries.size() < (capacity + SHARDS - 1) / SHARDS) {
+            s.entries.emplace(hash, std::move(value));
+        }
+    }
+
+    // not thread-safe, only to be called between iterations
+    template<typename P>
+    void erase_if(P predicate) {
+
+        for (std::size_t i = 0; i < SHARDS; ++i) {
+            std::erase_if(shards[i].entries, [&predicate](const auto &entry) { return predicate(entry.second); });
+        }
+    }
+
+    template<typename F>
+    void for_each(F function) const {
+
+        for (std::size_t i = 0; i < SHARDS; ++i) {
+            for (const auto &entry : shards[i].entries) {
+                function(entry.second);
+            }
+        }
+    }
+};
+
+// hash-consing table of hulls: each distinct hull is stored once
+class hull_table {
+
+    concurrent_table<hull_handle> hulls;
+    hull_handle empty;
+
+  public:
+    hull_table(): empty(std::make_shared<const std::vector<coordinate>>()) {}
+
+    const hull_handle &empty_hull() const {
+
+        return empty;
+    }
+
+    hull_handle intern(std::vector<coordinate> &&hull) {
+
+        if (hull.empty()) {
+            return empty;
+        }
+
+        return hulls.find_or_insert(hash_coordinates(hull),
+            [&hull](const hull_handle &h) { return *h == hull; },
+            [&hull]() { return std::make_shared<const std::vector<coordinate>>(std::move(hull)); }
+        );
+    }
+
+    // drop the hulls that are only referenced by this table
+    void purge() {
+
+        hulls.erase_if([](const hull_handle &h) { return h.use_count() == 1; });
+    }
+
+    auto size() const {
+
+        std::size_t size = 0;
+        hulls.for_each([&size](const hull_handle &) { size++; });
+        return size;
+    }
+
+    auto coordinates() const {
+
+        std::size_t coordinates = 0;
+        hulls.for_each([&coordinates](const hull_handle &h) { coordinates += h->size(); });
+        return coordinates;
+    }
+};
+
+// memoization table of Q: the hull of a state only depends on the hulls of its successors and on the rewards of its actions,
+// which are stored either by value (R = coordinate) or, when they come from a table of the environment, by address
+template<typename R>
+class q_table {
+
+  public:
+    struct key {
+        // successors are referred to by address, entries are purged as soon as one of them is no longer associated
+        // to any state (i.e., before it can be released), hence the addresses never dangle
+        std::vector<const std::vector<coordinate> *> successors; // one for each action
+        std::vector<R> rewards;                                   // one (flat vector of rewards) for each action
+
+        auto hash() const {
+
+            std::size_t seed = 0;
+            for (const auto s : successors) {
+                hash_combine(seed, std::hash<const void *>{}(s));
+            }
+            for (const auto r : rewards) {
+                hash_combine(seed, std::hash<R>{}(r));
+            }
+            return seed;
+        }
+
+        // successors are compared by identity, which is equivalent to comparing their contents since hulls are interned
+        bool operator==(const key &other) const {
+
+            return successors == other.successors && rewards == other.rewards;
+        }
+    };
+
+  private:
+    struct entry {
+        key k;
+        hull_handle hull;
+        std::size_t generation; // last sweep in which the entry has been inserted or hit
+    };
+
+    concurrent_table<entry> entries;
+    std::size_t capacity;
+
+  public:
+    // at most (roughly) capacity entries are kept, so that the memory usage of the table is bounded
+    explicit q_table(const std::size_t capacity): capacity(capacity) {}
+
+    // the lookup is performed under the lock of the shard, hence the entry can be refreshed in place
+    std::optional<hull_handle> find(const key &k, const std::size_t hash, const std::size_t generation) {
+
+        return entries.find(hash,
+            [&k](const entry &e) { return e.k == k; },
+            [generation](entry &e) { e.generation = generation; return e.hull; }
+        );
+    }
+
+    void insert(key &&k, const std::size_t hash, const hull_handle &hull, const std::size_t generation) {
+
+        entries.insert(hash, { std::move(k), hull, generation }, capacity);
+    }
+
+    // forget the entries referring to hulls which are no longer associated to any state, since they cannot be hit anymore,
+    // and the ones which have not been used in the last sweep, since they are unlikely to be hit again
+    void purge(const std::vector<hull_handle> &hulls, const std::size_t generation) {
+
+        std::unordered_set<const void *> live;
+        for (const auto &h : hulls) {
+            live.insert(h.get());
+        }
+        entries.erase_if([&live, generation](const entry &e) {
+            return e.generation != generation || std::any_of(std::begin(e.k.successors), std::end(e.k.successors), [&live](const auto s) {
+                return !live.contains(s);
+            });
+        });
+    }
+};
+
+#endif
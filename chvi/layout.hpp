@@ -0,0 +1,48 @@
+#ifndef LAYOUT_HPP_
+#define LAYOUT_HPP_
+
+#include "types.hpp"    // coordinate type
+#include <numeric>      // std::accumulate, std::partial_sum
+#include <functional>   // std::multiplies
+#include <vector>       // std::vector
+
+inline auto state2id(const std::vector<coordinate> &state, const std::vector<std::size_t> &ex_pfx_product) {
+
+    std::size_t id = 0;
+
+    for (std::size_t dimension = 0; dimension < state.size(); ++dimension) {
+        id += state[dimension] * ex_pfx_product[dimension];
+    }
+
+    return id;
+}
+
+inline auto id2state(const std::size_t id, const std::vector<std::size_t> &ex_pfx_product, const std::vector<std::size_t> &state_space_size) {
+
+    std::vector<coordinate> state(state_space_size.size());
+
+    for (std::size_t dimension = 0; dimension < state_space_size.size(); ++dimension) {
+        state[dimension] = (id / ex_pfx_product[dimension]) % state_space_size[dimension];
+    }
+
+    return state;
+}
+
+// indexing data structures, shared by all problems defined over the same state space
+struct layout {
+    std::vector<std::size_t> state_space_size;
+    std::vector<std::size_t> ex_pfx_product;
+    std::size_t n_states;
+};
+
+inline auto make_layout(const std::vector<std::size_t> &state_space_size) {
+
+    // data structure useful to associate each thread to a vector state
+    std::vector<std::size_t> ex_pfx_product(state_space_size.size(), 1ULL);
+    std::partial_sum(std::begin(state_space_size), std::end(state_space_size) - 1, std::begin(ex_pfx_product) + 1, std::multiplies<>());
+    const auto n_states = std::accumulate(std::begin(state_space_size), std::end(state_space_size), 1ULL, std::multiplies<>());
+
+    return layout { state_space_size, ex_pfx_product, n_states };
+}
+
+#endif
@@ -12,19 +12,19 @@
 
 static float progress;
 
-void log_title(std::string title) {
+inline void log_title(std::string title) {
 
     fmt::print("| {1:^{0}} |\n", TOTAL_WIDTH - 4, title);
     std::fflush(nullptr);
 }
 
-void log_line() {
+inline void log_line() {
 
     fmt::print("+{1:->{0}}+{1:->{0}}+\n", COLUMN_WIDTH + 2, "");
     std::fflush(nullptr);
 }
 
-void log_string(std::string name, std::string val, std::string param = "") {
+inline void log_string(std::string name, std::string val, std::string param = "") {
 
     fmt::print("| ");
     const size_t par_space = param.length() + param.length() ? 5 : 0;
@@ -46,7 +46,7 @@ void log_string(std::string name, std::string val, std::string param = "") {
     std::fflush(nullptr);
 }
 
-void log_progress_increase(float step, float tot) {
+inline void log_progress_increase(float step, float tot) {
 
     if (progress == tot) {
         return;
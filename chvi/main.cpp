@@ -3,18 +3,35 @@
 #include <fmt/core.h>
 #include <fmt/ranges.h>
 
-#include <string>   // std::stoull
-#include <unistd.h> // getopt
+#include <string>     // std::stoll, std::getline
+#include <fstream>    // std::ifstream
+#include <sstream>    // std::istringstream
+#include <map>        // std::map
+#include <filesystem> // std::filesystem::exists
+#include <unistd.h>   // getopt, access
 
 // Modules
 #include "env.hpp"
 #include "types.hpp"
 #include "chvi.hpp"
+#include "telemetry.hpp"
 
 static inline void print_usage(const char *bin) {
 
     fmt::print(stderr, "Usage: {} [-h] [-d dimensions] [-n size] [-s seed] [-g goals] ", bin);
-    fmt::print(stderr, "[-f discount_factor] [-i max_iterations] [-e epsilon] [-o] [-0]\n");
+    fmt::print(stderr, "[-f discount_factor] [-i max_iterations] [-e epsilon] [-b batch_file] [-w] [-o] [-0]\n");
+    fmt::print(stderr, "[-t telemetry_interval] [-T telemetry_file]\n");
+    fmt::print(stderr, "Each line of batch_file contains a \"seed discount_factor epsilon\" configuration (-s, -f and -e are ignored), blank lines are skipped\n");
+    fmt::print(stderr, "With -w the convex coverage set is computed by the weight-space (optimistic linear support) engine, one instance at a time with -b\n");
+    fmt::print(stderr, "With -t the progress is sampled every telemetry_interval seconds and written to stderr, or to telemetry_file (e.g., a named pipe)\n");
+    fmt::print(stderr, "With -T alone the progress is sampled every {} seconds\n", DEFAULT_TELEMETRY_INTERVAL);
+}
+
+// an existing file (e.g., a named pipe) must be writable, otherwise it must be possible to create it
+static inline bool writable(const std::string &path) {
+
+    const auto parent = std::filesystem::path(path).parent_path();
+    return std::filesystem::exists(path) ? access(path.c_str(), W_OK) == 0 : access(parent.empty() ? "." : parent.c_str(), W_OK) == 0;
 }
 
 #define parameter(CHAR, VAR, PARSE, CONDITION) \
@@ -36,22 +53,31 @@ int main(int argc, char** argv) {
     // default parameters
     int dimensions = 5;
     int size = 5;
-    std::size_t seed = 0;
+    // read as a signed value, so that negative seeds are rejected instead of wrapping around
+    long long seed = 0;
     double discount_factor = 1;
     int max_iterations = 100;
     double epsilon = 0.05;
     bool output = false;
     bool only_initial_state = false;
+    std::string batch_file;
+    bool weight_space = false;
+    double telemetry_interval = 0;
+    std::string telemetry_file;
 
     char opt;
-    while ((opt = getopt(argc, argv, "d:n:s:g:f:i:e:o0h")) != -1) {
+    while ((opt = getopt(argc, argv, "d:n:s:g:f:i:e:b:t:T:wo0h")) != -1) {
         switch (opt) {
             parameter('d', dimensions, std::stoi, dimensions >= 2);
             parameter('n', size, std::stoi, size >= 2);
-            parameter('s', seed, std::stoull, true);
+            parameter('s', seed, std::stoll, seed >= 0);
             parameter('f', discount_factor, std::stod, discount_factor > 0);
             parameter('i', max_iterations, std::stoi, max_iterations > 0);
             parameter('e', epsilon, std::stod, epsilon >= 0);
+            parameter('b', batch_file, std::string, std::ifstream(batch_file).good());
+            parameter('t', telemetry_interval, std::stod, telemetry_interval > 0);
+            parameter('T', telemetry_file, std::string, writable(telemetry_file));
+            flag('w', weight_space, true);
             flag('o', output, true);
             flag('0', only_initial_state, true);
             case 'h':
@@ -61,8 +87,61 @@ int main(int argc, char** argv) {
         }
     }
 
-    Env env {(std::size_t)dimensions, (std::size_t)size, seed};
-    const auto V = run_chvi(env, discount_factor, max_iterations, epsilon, !(output || only_initial_state));
+    if (!telemetry_file.empty() && telemetry_interval == 0) {
+        telemetry_interval = DEFAULT_TELEMETRY_INTERVAL;
+    }
+
+    set_telemetry(telemetry_interval, telemetry_file);
+
+    if (!batch_file.empty()) {
+        // environments are built once per seed and shared by all the instances that refer to them
+        std::map<long long, Env> envs;
+        std::vector<instance> instances;
+        std::ifstream batch(batch_file);
+        std::string line;
+        for (std::size_t n = 1; std::getline(batch, line); ++n) {
+            // blank lines are skipped, any other line must contain exactly three valid fields
+            if (line.find_first_not_of(" \t\r") == std::string::npos) {
+                continue;
+            }
+            std::istringstream fields(line);
+            std::string extra;
+            if (!(fields >> seed >> discount_factor >> epsilon) || (fields >> extra) || !(seed >= 0 && discount_factor > 0 && epsilon >= 0)) {
+                fmt::print(stderr, "{}: invalid configuration at line {} of '{}'\n", argv[0], n, batch_file);
+                return EXIT_FAILURE;
+            }
+            const auto [ it, inserted ] = envs.try_emplace(seed, (std::size_t)dimensions, (std::size_t)size, (std::size_t)seed);
+            (void) inserted;
+            instances.push_back({ it->second, discount_factor, epsilon });
+        }
+        if (instances.empty()) {
+            fmt::print(stderr, "{}: no configuration in '{}'\n", argv[0], batch_file);
+            return EXIT_FAILURE;
+        }
+        std::vector<std::vector<std::vector<coordinate>>> Vs;
+        if (weight_space) {
+            // the weight-space engine has no batch mode, instances are solved one after the other
+            for (const auto &instance : instances) {
+                Vs.push_back(run_ols(instance.env, instance.discount_factor, max_iterations, instance.epsilon, !(output || only_initial_state)));
+            }
+        } else {
+            Vs = run_chvi_batch(instances, max_iterations, !(output || only_initial_state));
+        }
+        for (const auto &V : Vs) {
+            if (output) {
+                fmt::print("{}\n", V);
+            }
+            if (only_initial_state) {
+                fmt::print("{}\n", V[0]);
+            }
+        }
+        return EXIT_SUCCESS;
+    }
+
+    Env env {(std::size_t)dimensions, (std::size_t)size, (std::size_t)seed};
+    const auto V = weight_space ?
+        run_ols(env, discount_factor, max_iterations, epsilon, !(output || only_initial_state)) :
+        run_chvi(env, discount_factor, max_iterations, epsilon, !(output || only_initial_state));
 
     if (output) {
         fmt::print("{}\n", V);
@@ -0,0 +1,497 @@
+#include "chvi.hpp"
+
+#include <algorithm> // std::any_of, std::transform
+#include <numeric>   // std::inner_product, std::iota, std::accumulate
+#include <chrono>    // std::chrono::system_clock
+#include <cmath>     // std::abs, std::llround
+#include <cstdint>   // std::int64_t
+#include <deque>     // std::deque
+#include <limits>    // std::numeric_limits
+#include <map>       // std::map
+#include <optional>  // std::optional
+#include <set>       // std::set
+
+// fmt library
+#define FMT_HEADER_ONLY
+#include <fmt/core.h>
+#include <fmt/ranges.h>
+#include <fmt/chrono.h>
+
+// modules
+#include "types.hpp"
+#include "convex_hull.hpp"
+#include "layout.hpp"
+#include "point.hpp"
+#include "telemetry.hpp"
+#include "log.hpp"
+
+#ifdef CYTHON
+#include <wrapper.h>
+#else
+#include <omp.h>     // omp_get_max_threads
+#endif
+
+// tolerance used to break ties, to compare weights and to detect the convergence of value iteration
+constexpr double OLS_TOLERANCE = 1e-6;
+
+// transitions of the environment, queried once and reused by the value iteration of every weight
+struct transitions {
+    std::size_t n_states;
+    std::size_t action_space_size;
+    std::size_t dimensions;
+    std::vector<char> terminal;
+    std::vector<std::size_t> successors; // one for each (state, action) pair
+    std::vector<double> rewards;         // flat vector of rewards, one for each (state, action) pair
+};
+
+auto make_transitions(env_type env, const layout &grid) {
+
+    const auto action_space_size = get_action_space_size(env);
+    const auto dimensions = grid.state_space_size.size();
+    transitions t {
+        grid.n_states, action_space_size, dimensions,
+        std::vector<char>(grid.n_states),
+        std::vector<std::size_t>(grid.n_states * action_space_size),
+        std::vector<double>(grid.n_states * action_space_size * dimensions)
+    };
+
+    #ifndef CYTHON
+    #pragma omp parallel for
+    #endif
+    for (std::size_t id = 0; id < grid.n_states; ++id) {
+        #ifdef TRANSITION_TABLE
+        t.terminal[id] = is_terminal_id(env, id);
+        for (std::size_t action = 0; action < action_space_size; ++action) {
+            const auto rewards = get_reward(env, id, action);
+            t.successors[id * action_space_size + action] = get_successor(env, id, action);
+            std::copy(rewards, rewards + dimensions, std::begin(t.rewards) + (id * action_space_size + action) * dimensions);
+        }
+        #else
+        const auto state = id2state(id, grid.ex_pfx_product, grid.state_space_size);
+        t.terminal[id] = is_terminal(env, state);
+        for (std::size_t action = 0; action < action_space_size; ++action) {
+            const auto [ next_state, rewards ] = execute_action(env, state, action);
+            t.successors[id * action_space_size + action] = state2id(next_state, grid.ex_pfx_product);
+            std::copy(std::begin(rewards), std::end(rewards), std::begin(t.rewards) + (id * action_space_size + action) * dimensions);
+        }
+        #endif
+    }
+
+    return t;
+}
+
+template<typename A, typename B>
+inline auto dot(const A &a, const B &b) {
+
+    return std::inner_product(std::begin(a), std::end(a), std::begin(b), 0.0);
+}
+
+// value iteration on the rewards scalarised with the given weight, returning the vector value of each state
+// ties are broken in favour of the highest sum of rewards, so that the policy stays Pareto optimal (and free of
+// zero-cost cycles) even when some components of the weight are zero
+template<typename W>
+auto scalarised_value_iteration(const transitions &t, const W &weight, const double discount_factor,
+                                const std::size_t max_iterations, std::size_t &sweeps, telemetry *monitor) {
+
+    const auto d = t.dimensions;
+    std::vector<double> value(t.n_states), new_value(t.n_states);
+    std::vector<double> tie(t.n_states), new_tie(t.n_states);
+    std::vector<double> vector_value(t.n_states * d), new_vector_value(t.n_states * d);
+
+    for (std::size_t iteration = 0; iteration < max_iterations; ++iteration) {
+        double change = 0;
+        if (monitor) {
+            monitor->begin_sweep(sweeps + 1, t.n_states);
+        }
+        #ifndef CYTHON
+        #pragma omp parallel for reduction(max:change)
+        #endif
+        for (std::size_t id = 0; id < t.n_states; ++id) {
+            // each state gets a single value vector
+            if (monitor) {
+                monitor->record(telemetry_thread(), !t.terminal[id]);
+            }
+            if (t.terminal[id]) {
+                continue;
+            }
+            auto best = std::numeric_limits<double>::lowest();
+            auto best_tie = std::numeric_limits<double>::lowest();
+            std::size_t best_action = 0;
+            for (std::size_t action = 0; action < t.action_space_size; ++action) {
+                const auto next = t.successors[id * t.action_space_size + action];
+                const auto rewards = &t.rewards[(id * t.action_space_size + action) * d];
+                auto scalar = discount_factor * value[next];
+                auto secondary = discount_factor * tie[next];
+                for (std::size_t c = 0; c < d; ++c) {
+                    scalar += weight[c] * rewards[c];
+                    secondary += rewards[c];
+                }
+                if (scalar > best + OLS_TOLERANCE || (scalar >= best - OLS_TOLERANCE && secondary > best_tie)) {
+                    best = scalar;
+                    best_tie = secondary;
+                    best_action = action;
+                }
+            }
+            const auto next = t.successors[id * t.action_space_size + best_action];
+            const auto rewards = &t.rewards[(id * t.action_space_size + best_action) * d];
+            for (std::size_t c = 0; c < d; ++c) {
+                new_vector_value[id * d + c] = rewards[c] + discount_factor * vector_value[next * d + c];
+                change = std::max(change, std::abs(new_vector_value[id * d + c] - vector_value[id * d + c]));
+            }
+            change = std::max(change, std::max(std::abs(best - value[id]), std::abs(best_tie - tie[id])));
+            new_value[id] = best;
+            new_tie[id] = best_tie;
+        }
+        std::swap(value, new_value);
+        std::swap(tie, new_tie);
+        std::swap(vector_value, new_vector_value);
+        sweeps++;
+        if (change <= OLS_TOLERANCE) {
+            break;
+        }
+    }
+
+    return vector_value;
+}
+
+// solve in place the square linear system a x = b (a in row-major order) by Gaussian elimination with partial pivoting,
+// leaving the solution in b, whose size is the number of unknowns
+template<typename M, typename V>
+bool solve_linear_system(M &a, V &b) {
+
+    const auto n = b.size();
+
+    for (std::size_t col = 0; col < n; ++col) {
+        std::size_t pivot = col;
+        for (std::size_t row = col + 1; row < n; ++row) {
+            if (std::abs(a[row * n + col]) > std::abs(a[pivot * n + col])) {
+                pivot = row;
+            }
+        }
+        if (std::abs(a[pivot * n + col]) < OLS_TOLERANCE) {
+            return false;
+        }
+        if (pivot != col) {
+            std::swap_ranges(std::begin(a) + pivot * n, std::begin(a) + (pivot + 1) * n, std::begin(a) + col * n);
+            std::swap(b[pivot], b[col]);
+        }
+        for (std::size_t row = col + 1; row < n; ++row) {
+            const auto factor = a[row * n + col] / a[col * n + col];
+            for (std::size_t k = col; k < n; ++k) {
+                a[row * n + k] -= factor * a[col * n + k];
+            }
+            b[row] -= factor * b[col];
+        }
+    }
+
+    for (std::size_t row = n; row-- > 0;) {
+        for (std::size_t k = row + 1; k < n; ++k) {
+            b[row] -= a[row * n + k] * b[k];
+        }
+        b[row] /= a[row * n + row];
+    }
+
+    return true;
+}
+
+// scalarised value of the current (non-empty) convex coverage set for the given weight
+template<typename P, typename W>
+auto surface(const std::vector<P> &ccs, const W &weight) {
+
+    auto value = dot(weight, ccs.front());
+
+    for (const auto &v : ccs) {
+        value = std::max(value, dot(weight, v));
+    }
+
+    return value;
+}
+
+// corner of the upper surface max_i w · ccs[i] over the simplex of weights, i.e., a solution of sum(w) = 1 and of d
+// constraints, each of which is either w[j] = 0 (constraint j < d) or w · ccs[i] = u (constraint d + i)
+template<std::size_t D>
+struct corner {
+    point<D, double> weight;
+    double value;   // u, i.e., the height of the upper surface at weight
+};
+
+// weights are looked up after being rounded to the tolerance, so that the same corner reached by means of different
+// constraints is only found once
+template<std::size_t D>
+auto weight_key(const point<D, double> &weight) {
+
+    auto key = make_point<point<D, std::int64_t>>(weight.size());
+    std::transform(std::begin(weight), std::end(weight), std::begin(key), [](double w) { return std::llround(w / OLS_TOLERANCE); });
+
+    return key;
+}
+
+template<std::size_t D>
+using corner_map = std::map<point<D, std::int64_t>, corner<D>>;
+
+// extremum j of the simplex of weights, which is a corner of the upper surface of any single vector
+template<std::size_t D>
+auto extremum(const std::size_t j, const std::size_t d) {
+
+    corner<D> c { make_point<point<D, double>>(d), 0 };
+    c.weight[j] = 1;
+
+    return c;
+}
+
+// constraints satisfied with equality at the given corner, which are more than d if the corner is degenerate
+template<std::size_t D>
+void insert_tight_constraints(std::set<std::size_t> &constraints, const std::vector<point<D, double>> &ccs, const corner<D> &c) {
+
+    const auto d = c.weight.size();
+
+    for (std::size_t j = 0; j < d; ++j) {
+        if (c.weight[j] <= OLS_TOLERANCE) {
+            constraints.insert(j);
+        }
+    }
+    for (std::size_t i = 0; i < ccs.size(); ++i) {
+        if (std::abs(dot(c.weight, ccs[i]) - c.value) <= OLS_TOLERANCE) {
+            constraints.insert(d + i);
+        }
+    }
+}
+
+// corner defined by the given constraints, if it lies in the simplex and on the upper surface
+template<std::size_t D>
+auto solve_corner(const std::vector<point<D, double>> &ccs, const point<D, std::size_t> &active) -> std::optional<corner<D>> {
+
+    const auto d = active.size();
+    // unknowns are (w[0], ..., w[d - 1], u)
+    auto a = make_point<point<D == 0 ? 0 : (D + 1) * (D + 1), double>>((d + 1) * (d + 1));
+    auto b = make_point<point<D == 0 ? 0 : D + 1, double>>(d + 1);
+    std::fill(std::begin(a), std::end(a), 0.0);
+    std::fill(std::begin(b), std::end(b), 0.0);
+    std::fill(std::begin(a), std::begin(a) + d, 1.0);
+    b[0] = 1;
+    for (std::size_t k = 0; k < d; ++k) {
+        const auto row = (k + 1) * (d + 1);
+        if (active[k] < d) {
+            a[row + active[k]] = 1;
+        } else {
+            std::copy(std::begin(ccs[active[k] - d]), std::end(ccs[active[k] - d]), std::begin(a) + row);
+            a[row + d] = -1;
+        }
+    }
+
+    if (!solve_linear_system(a, b)) {
+        return std::nullopt;
+    }
+
+    auto weight = make_point<point<D, double>>(b.data(), d);
+    const auto u = b[d];
+    if (std::any_of(std::begin(weight), std::end(weight), [](double w) { return w < -OLS_TOLERANCE; }) ||
+        surface(ccs, weight) > u + OLS_TOLERANCE) {
+        return std::nullopt;
+    }
+
+    std::transform(std::begin(weight), std::end(weight), std::begin(weight), [](double w) { return std::max(w, 0.0); });
+    const auto sum = std::accumulate(std::begin(weight), std::end(weight), 0.0);
+    std::transform(std::begin(weight), std::end(weight), std::begin(weight), [sum](double w) { return w / sum; });
+
+    return corner<D> { std::move(weight), u };
+}
+
+// incremental update of the corners once ccs.back() has been added to the convex coverage set: the corners it cuts are
+// removed, and the new ones lie on the boundary of the region where it is maximal, hence each of them is defined by the
+// new vector and by d - 1 of the constraints of the removed corners (i.e., only these systems are solved), returning the
+// new corners
+template<std::size_t D>
+auto update_corners(const std::vector<point<D, double>> &ccs, corner_map<D> &corners) {
+
+    const auto &v = ccs.back();
+    const auto d = v.size();
+    std::set<std::size_t> boundary;
+    std::erase_if(corners, [&](const auto &entry) {
+        if (dot(entry.second.weight, v) <= entry.second.value + OLS_TOLERANCE) {
+            return false;
+        }
+        insert_tight_constraints(boundary, ccs, entry.second);
+        return true;
+    });
+    // the new vector is tight at the removed corners only if their surface is cut by less than the tolerance
+    boundary.erase(d + ccs.size() - 1);
+
+    const std::vector<std::size_t> constraints(std::begin(boundary), std::end(boundary));
+    std::vector<corner<D>> added;
+
+    if (constraints.size() < d - 1) {
+        return added;
+    }
+
+    // enumerate all the (d - 1)-combinations of the constraints
+    auto active = make_point<point<D, std::size_t>>(d);
+    std::vector<std::size_t> chosen(d - 1);
+    std::iota(std::begin(chosen), std::end(chosen), 0);
+    active.back() = d + ccs.size() - 1;
+
+    while (true) {
+        for (std::size_t k = 0; k < d - 1; ++k) {
+            active[k] = constraints[chosen[k]];
+        }
+        if (auto c = solve_corner<D>(ccs, active)) {
+            if (corners.try_emplace(weight_key<D>(c->weight), *c).second) {
+                added.push_back(std::move(*c));
+            }
+        }
+        // next combination in lexicographic order
+        std::size_t k = d - 1;
+        while (k > 0 && chosen[k - 1] == constraints.size() - (d - 1) + (k - 1)) {
+            k--;
+        }
+        if (k == 0) {
+            break;
+        }
+        chosen[k - 1]++;
+        for (std::size_t j = k; j < d - 1; ++j) {
+            chosen[j] = chosen[j - 1] + 1;
+        }
+    }
+
+    return added;
+}
+
+struct ols_statistics {
+    std::size_t evaluated = 0;
+    std::size_t sweeps = 0;
+    std::size_t ccs = 0;
+};
+
+// optimistic linear support on the initial state, returning the value vectors found for it
+template<std::size_t D>
+auto optimistic_linear_support(const transitions &t, const double discount_factor, const std::size_t max_iterations,
+                               const double epsilon, const bool verbose, ols_statistics &statistics) {
+
+    const auto d = t.dimensions;
+
+    // convex coverage set of the initial state, and the value vectors found for it
+    std::vector<point<D, double>> ccs;
+    std::set<std::vector<coordinate>> found;
+
+    // corners of the upper surface, and the ones still to be evaluated, which are initially the extrema of the simplex
+    corner_map<D> corners;
+    std::set<point<D, std::int64_t>> evaluated;
+    std::deque<corner<D>> queue;
+    for (std::size_t c = 0; c < d; ++c) {
+        queue.push_back(extremum<D>(c, d));
+    }
+
+    const auto monitor = make_telemetry();
+
+    while (!queue.empty()) {
+        const auto weight = std::move(queue.front().weight);
+        queue.pop_front();
+        evaluated.insert(weight_key<D>(weight));
+        statistics.evaluated++;
+        const auto vector_value = scalarised_value_iteration(t, weight, discount_factor, max_iterations, statistics.sweeps, monitor.get());
+        if (!t.terminal[0]) {
+            found.emplace(std::begin(vector_value), std::begin(vector_value) + d);
+        }
+        const auto v = make_point<point<D, double>>(vector_value.data(), d);
+        if (ccs.empty()) {
+            // the first vector always belongs to the convex coverage set, the remaining extrema stay queued
+            if (verbose) {
+                log_string(fmt::format("Corner weight {}", statistics.evaluated), fmt::format("{:.5f} (first vector)", dot(weight, v)));
+            }
+            ccs.push_back(v);
+            for (std::size_t c = 0; c < d; ++c) {
+                auto e = extremum<D>(c, d);
+                e.value = v[c];
+                corners.emplace(weight_key<D>(e.weight), std::move(e));
+            }
+            for (auto &c : queue) {
+                c.value = dot(c.weight, v);
+            }
+            continue;
+        }
+        const auto improvement = dot(weight, v) - surface(ccs, weight);
+        if (verbose) {
+            log_string(fmt::format("Corner weight {}", statistics.evaluated), fmt::format("{:.5f} ({} vectors)", improvement, ccs.size()));
+        }
+        if (improvement > std::max(epsilon, OLS_TOLERANCE)) {
+            // queued weights improved by the new vector are not corners of the upper surface anymore
+            std::erase_if(queue, [&v](const auto &c) { return dot(c.weight, v) > c.value + OLS_TOLERANCE; });
+            ccs.push_back(v);
+            for (auto &c : update_corners(ccs, corners)) {
+                if (!evaluated.contains(weight_key<D>(c.weight))) {
+                    queue.push_back(std::move(c));
+                }
+            }
+        }
+    }
+
+    statistics.ccs = ccs.size();
+
+    return found;
+}
+
+std::vector<std::vector<coordinate>> run_ols(env_type env, const double discount_factor, const std::size_t max_iterations,
+                                             const double epsilon, const bool verbose) {
+
+    auto start = std::chrono::system_clock::now();
+    const auto grid = make_layout(get_observation_space_size(env));
+    const auto n_goals = get_n_goals(env);
+    const auto d = grid.state_space_size.size();
+
+    if (verbose) {
+        log_line();
+        log_title("Optimistic Linear Support");
+        log_title("https://github.com/filippobistaffa/chvi");
+        log_line();
+        log_title("Environment Statistics");
+        log_line();
+        log_string("State space size", fmt::format("{} ({} states)", grid.state_space_size, grid.n_states));
+        log_string("Number of goal states", fmt::format("{} ({:.2f}%)", n_goals, 100.0 * n_goals / grid.n_states));
+        log_fmt("Action space size", get_action_space_size(env));
+        log_line();
+        log_title("Algorithm Parameters");
+        log_line();
+        log_fmt("Discount factor", discount_factor);
+        log_fmt("Maximum number of iterations", max_iterations);
+        log_fmt("Epsilon", epsilon);
+        #ifndef CYTHON
+        log_fmt("Available parallel threads", omp_get_max_threads());
+        #endif
+        log_line();
+        log_title("Improvement of Corner Weights");
+        log_line();
+    }
+
+    const auto t = make_transitions(env, grid);
+    ols_statistics statistics;
+    const auto found = dispatch_dimensions(d, [&]<std::size_t D>() {
+        return optimistic_linear_support<D>(t, discount_factor, max_iterations, epsilon, verbose, statistics);
+    });
+
+    // corner weights are only those of the initial state, hence the other states are left empty
+    std::vector<std::vector<coordinate>> hulls(grid.n_states);
+
+    if (!found.empty()) {
+        hulls[0] = flatten(non_dominated(std::vector(std::begin(found), std::end(found))));
+    }
+
+    if (verbose) {
+        log_line();
+        log_title("Algorithm Statistics");
+        log_line();
+        log_fmt("Evaluated corner weights", statistics.evaluated);
+        log_fmt("Value iteration sweeps", statistics.sweeps);
+        log_fmt("Size of the initial convex coverage set", statistics.ccs);
+        log_string("Runtime", fmt::format("{:%T}", std::chrono::system_clock::now() - start));
+        log_line();
+    }
+
+    return hulls;
+}
+
+void run_ols_csr(env_type env, const double discount_factor, const std::size_t max_iterations, const double epsilon, const bool verbose,
+                 std::vector<std::size_t> &offsets, std::vector<coordinate> &points) {
+
+    const auto dimensions = get_observation_space_size(env).size();
+    to_csr(run_ols(env, discount_factor, max_iterations, epsilon, verbose), dimensions, offsets, points);
+}
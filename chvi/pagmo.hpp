@@ -2,7 +2,8 @@
 #define PAGMO_HPP_
 
 // Code extracted from https://github.com/esa/pagmo2 without modifications,
-// apart from pareto_dominance() routine, which was adapted for maximization
+// apart from pareto_dominance() routine, which was adapted for maximization,
+// and from the type of the points, which can be any random access container
 
 #include <stdexcept>
 #include <type_traits>
@@ -105,8 +106,8 @@ inline bool less_than_f(T a, T b)
 using fnds_return_type = std::tuple<std::vector<std::vector<pop_size_t>>, std::vector<std::vector<pop_size_t>>,
                                     std::vector<pop_size_t>, std::vector<pop_size_t>>;
 
-template<typename T>
-bool pareto_dominance(const std::vector<T> &obj1, const std::vector<T> &obj2)
+template<typename P>
+bool pareto_dominance(const P &obj1, const P &obj2)
 {
     if (obj1.size() != obj2.size()) {
         pagmo_throw(std::invalid_argument,
@@ -124,8 +125,8 @@ bool pareto_dominance(const std::vector<T> &obj1, const std::vector<T> &obj2)
     return found_strictly_dominating_dimension;
 }
 
-template<typename T>
-fnds_return_type fast_non_dominated_sorting(const std::vector<std::vector<T>> &points)
+template<typename P>
+fnds_return_type fast_non_dominated_sorting(const std::vector<P> &points)
 {
     auto N = points.size();
     // We make sure to have two points at least (one could also be allowed)
@@ -0,0 +1,62 @@
+#ifndef POINT_HPP_
+#define POINT_HPP_
+
+#include "types.hpp"    // coordinate type
+#include <array>        // std::array
+#include <type_traits>  // std::conditional_t
+#include <utility>      // std::forward
+#include <vector>       // std::vector
+
+// points whose number of dimensions D is known at compile time are stored in fixed-size arrays, which avoid a heap
+// allocation per point and let the compiler fully unroll loops over coordinates, while D = 0 denotes a point whose
+// number of dimensions is only known at runtime
+template<std::size_t D, typename T = coordinate>
+using point = std::conditional_t<D == 0, std::vector<T>, std::array<T, D>>;
+
+template<typename P>
+constexpr std::size_t static_dimensions = 0;
+
+template<typename T, std::size_t D>
+constexpr std::size_t static_dimensions<std::array<T, D>> = D;
+
+template<typename P>
+inline auto make_point(const std::size_t dimensions) {
+
+    if constexpr (static_dimensions<P> == 0) {
+        return P(dimensions);
+    } else {
+        return P {};
+    }
+}
+
+template<typename P, typename T>
+inline auto make_point(const T *coordinates, const std::size_t dimensions) {
+
+    auto p = make_point<P>(dimensions);
+
+    for (std::size_t c = 0; c < p.size(); ++c) {
+        p[c] = coordinates[c];
+    }
+
+    return p;
+}
+
+// largest number of dimensions for which the solver is specialised at compile time
+constexpr std::size_t MAX_STATIC_DIMENSIONS = 8;
+
+// invoke f.template operator()<D>() with D equal to the given number of dimensions, if a specialisation exists,
+// or with D = 0 (i.e., the generic implementation) otherwise
+template<std::size_t D = 2, typename F>
+inline auto dispatch_dimensions(const std::size_t dimensions, F &&f) {
+
+    if constexpr (D > MAX_STATIC_DIMENSIONS) {
+        return f.template operator()<0>();
+    } else {
+        if (dimensions == D) {
+            return f.template operator()<D>();
+        }
+        return dispatch_dimensions<D + 1>(dimensions, std::forward<F>(f));
+    }
+}
+
+#endif
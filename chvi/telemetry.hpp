@@ -0,0 +1,226 @@
+#ifndef TELEMETRY_HPP_
+#define TELEMETRY_HPP_
+
+#include <atomic>               // std::atomic
+#include <cerrno>               // errno, ENXIO, EAGAIN
+#include <chrono>               // std::chrono::steady_clock
+#include <condition_variable>   // std::condition_variable
+#include <csignal>              // sigset_t, SIGPIPE
+#include <cstdio>               // stderr
+#include <cstring>              // std::strerror
+#include <fcntl.h>              // open, fcntl
+#include <fstream>              // std::ifstream
+#include <memory>               // std::unique_ptr
+#include <mutex>                // std::mutex
+#include <string>               // std::string
+#include <thread>               // std::thread
+#include <pthread.h>            // pthread_sigmask
+#include <unistd.h>             // sysconf, write, close
+
+#ifndef CYTHON
+#include <omp.h>                // omp_get_max_threads, omp_get_thread_num
+#endif
+
+// fmt library
+#define FMT_HEADER_ONLY
+#include <fmt/core.h>
+#include <fmt/chrono.h>
+
+// seconds between two samples when only the consumer is given
+constexpr double DEFAULT_TELEMETRY_INTERVAL = 10;
+
+// telemetry settings, disabled (i.e., interval = 0) by default
+struct telemetry_settings {
+    double interval = 0;    // seconds between two samples
+    std::string path;       // consumer of the samples (e.g., a file or a named pipe), stderr if empty
+};
+
+inline telemetry_settings telemetry_config;
+
+// progress of a single thread, padded to its own cache line to avoid false sharing
+struct alignas(64) progress_counter {
+    std::atomic<std::size_t> states = 0;
+    std::atomic<std::size_t> points = 0;
+};
+
+// background thread periodically sampling the progress counters of the solver threads
+class telemetry {
+
+    std::size_t n_threads;
+    std::unique_ptr<progress_counter[]> counters;
+    std::atomic<std::size_t> iteration = 0;
+    std::atomic<std::size_t> sweep_start = 0;
+    std::atomic<std::size_t> sweep_size = 0;
+    std::string path;
+    int output = -1;
+    std::size_t dropped = 0;
+    std::mutex mutex;
+    std::condition_variable stop_signal;
+    std::atomic<bool> stopping = false;
+    std::thread sampler;
+
+    auto total(std::atomic<std::size_t> progress_counter::*counter) const {
+
+        std::size_t sum = 0;
+        for (std::size_t t = 0; t < n_threads; ++t) {
+            sum += (counters[t].*counter).load(std::memory_order_relaxed);
+        }
+        return sum;
+    }
+
+    static auto resident_set_size() {
+
+        std::size_t pages = 0;
+        std::size_t resident = 0;
+        std::ifstream statm("/proc/self/statm");
+        statm >> pages >> resident;
+        return resident * sysconf(_SC_PAGESIZE);
+    }
+
+    // open the consumer in non-blocking mode, a named pipe is only opened once a reader is attached (i.e., the
+    // open fails with ENXIO until then) and a sample which does not fit in its buffer is dropped (i.e., the write
+    // fails with EAGAIN), so that neither the solver nor its termination ever wait for the consumer
+    bool open_output() {
+
+        if (path.empty()) {
+            output = STDERR_FILENO;
+            return true;
+        }
+
+        output = open(path.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_NONBLOCK, 0644);
+        if (output < 0) {
+            if (errno != ENXIO) {
+                fmt::print(stderr, "telemetry: cannot open '{}' ({}), writing to stderr\n", path, std::strerror(errno));
+                output = STDERR_FILENO;
+                return true;
+            }
+            return false;
+        }
+
+        return true;
+    }
+
+    // samples are shorter than PIPE_BUF, hence each one is either written entirely or not at all
+    void emit(const std::string &line) {
+
+        if (write(output, line.data(), line.size()) >= 0) {
+            return;
+        }
+
+        if (errno == EAGAIN) {
+            dropped++;
+        } else if (output != STDERR_FILENO) {
+            // the consumer went away, wait for a new one
+            close(output);
+            output = -1;
+        }
+    }
+
+    void sample(const std::chrono::duration<double> interval) {
+
+        // a consumer which goes away makes the writes fail with EPIPE instead of terminating the process
+        sigset_t pipe;
+        sigemptyset(&pipe);
+        sigaddset(&pipe, SIGPIPE);
+        pthread_sigmask(SIG_BLOCK, &pipe, nullptr);
+
+        const auto start = std::chrono::steady_clock::now();
+        auto last = start;
+        std::size_t last_states = 0;
+        std::size_t last_points = 0;
+
+        open_output();
+        while (true) {
+            {
+                // the lock is only held while waiting, never while writing
+                std::unique_lock<std::mutex> lock(mutex);
+                if (stop_signal.wait_for(lock, interval, [this]() { return stopping.load(); })) {
+                    break;
+                }
+            }
+            if (output < 0 && !open_output()) {
+                continue;
+            }
+            const auto now = std::chrono::steady_clock::now();
+            const auto elapsed = std::chrono::duration<double>(now - last).count();
+            const auto states = total(&progress_counter::states);
+            const auto points = total(&progress_counter::points);
+            const auto states_rate = (states - last_states) / elapsed;
+            const auto points_rate = (points - last_points) / elapsed;
+            // estimated time to the end of the current iteration
+            const auto done = std::min(states - sweep_start.load(std::memory_order_relaxed), sweep_size.load(std::memory_order_relaxed));
+            const auto remaining = sweep_size.load(std::memory_order_relaxed) - done;
+            const auto eta = states_rate > 0 ? fmt::format("{:%T}", std::chrono::seconds((std::size_t)(remaining / states_rate))) : "--:--:--";
+            emit(fmt::format("[{:%T}] iteration {} ({:.1f}%) | {:.0f} states/s | {:.0f} points/s | RSS {:.1f} MB | ETA {} | {} dropped\n",
+                std::chrono::floor<std::chrono::seconds>(now - start), iteration.load(std::memory_order_relaxed),
+                sweep_size ? 100.0 * done / sweep_size : 0.0, states_rate, points_rate,
+                resident_set_size() / (1024.0 * 1024.0), eta, dropped
+            ));
+            last = now;
+            last_states = states;
+            last_points = points;
+        }
+    }
+
+  public:
+    telemetry(const std::size_t n_threads, const double interval, const std::string &path):
+        n_threads(n_threads), counters(std::make_unique<progress_counter[]>(n_threads)), path(path) {
+
+            sampler = std::thread(&telemetry::sample, this, std::chrono::duration<double>(interval));
+        }
+
+    ~telemetry() {
+
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            stopping = true;
+        }
+        stop_signal.notify_one();
+        sampler.join();
+        if (output >= 0 && output != STDERR_FILENO) {
+            close(output);
+        }
+    }
+
+    // each counter is only written by its own thread, hence a relaxed load and store suffice (no locked instruction)
+    void record(const std::size_t thread, const std::size_t points) {
+
+        auto &c = counters[thread];
+        c.states.store(c.states.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+        c.points.store(c.points.load(std::memory_order_relaxed) + points, std::memory_order_relaxed);
+    }
+
+    // to be called between iterations, when no thread is updating its counter
+    void begin_sweep(const std::size_t i, const std::size_t states) {
+
+        sweep_start.store(total(&progress_counter::states), std::memory_order_relaxed);
+        sweep_size.store(states, std::memory_order_relaxed);
+        iteration.store(i, std::memory_order_relaxed);
+    }
+};
+
+// index of the progress counter of the calling thread
+inline std::size_t telemetry_thread() {
+
+    #ifndef CYTHON
+    return omp_get_thread_num();
+    #else
+    return 0;
+    #endif
+}
+
+// start the telemetry thread if enabled by the current settings, with one progress counter for each solver thread
+inline auto make_telemetry() {
+
+    #ifndef CYTHON
+    const std::size_t n_threads = omp_get_max_threads();
+    #else
+    const std::size_t n_threads = 1;
+    #endif
+
+    return telemetry_config.interval > 0 ?
+        std::make_unique<telemetry>(n_threads, telemetry_config.interval, telemetry_config.path) :
+        std::unique_ptr<telemetry>();
+}
+
+#endif
@@ -5,11 +5,68 @@ import numpy as np
 from libcpp.vector cimport vector as cpp_vector
 from libcpp.pair cimport pair as cpp_pair
 from libcpp cimport bool
+from cpython cimport Py_buffer
 
 
 # import C++ functions
 cdef extern from "chvi.hpp":
-    cpp_vector[cpp_vector[float]] run_chvi(env, float discount_factor, size_t max_iterations, float epsilon, bool verbose)
+    void run_chvi_csr(env, float discount_factor, size_t max_iterations, float epsilon, bool verbose, cpp_vector[size_t] &offsets, cpp_vector[float] &points)
+    void run_ols_csr(env, float discount_factor, size_t max_iterations, float epsilon, bool verbose, cpp_vector[size_t] &offsets, cpp_vector[float] &points)
+
+
+# owners of the buffers filled by the C++ code, exposed to NumPy by means of the buffer protocol (i.e., without copies)
+cdef class _Offsets:
+    cdef cpp_vector[size_t] data
+    cdef Py_ssize_t shape[1]
+    cdef Py_ssize_t strides[1]
+
+    def __getbuffer__(self, Py_buffer *buffer, int flags):
+        self.shape[0] = self.data.size()
+        self.strides[0] = sizeof(size_t)
+        if sizeof(size_t) == sizeof(unsigned long):
+            buffer.format = b'L'
+        else:
+            buffer.format = b'Q'
+        buffer.buf = <char *> self.data.data()
+        buffer.internal = NULL
+        buffer.itemsize = sizeof(size_t)
+        buffer.len = self.data.size() * sizeof(size_t)
+        buffer.ndim = 1
+        buffer.obj = self
+        buffer.readonly = 0
+        buffer.shape = self.shape
+        buffer.strides = self.strides
+        buffer.suboffsets = NULL
+
+    def __releasebuffer__(self, Py_buffer *buffer):
+        pass
+
+
+cdef class _Points:
+    cdef cpp_vector[float] data
+    cdef Py_ssize_t dimensions
+    cdef Py_ssize_t shape[2]
+    cdef Py_ssize_t strides[2]
+
+    def __getbuffer__(self, Py_buffer *buffer, int flags):
+        self.shape[0] = self.data.size() // self.dimensions
+        self.shape[1] = self.dimensions
+        self.strides[0] = self.dimensions * sizeof(float)
+        self.strides[1] = sizeof(float)
+        buffer.buf = <char *> self.data.data()
+        buffer.format = b'f'
+        buffer.internal = NULL
+        buffer.itemsize = sizeof(float)
+        buffer.len = self.data.size() * sizeof(float)
+        buffer.ndim = 2
+        buffer.obj = self
+        buffer.readonly = 0
+        buffer.shape = self.shape
+        buffer.strides = self.strides
+        buffer.suboffsets = NULL
+
+    def __releasebuffer__(self, Py_buffer *buffer):
+        pass
 
 
 cdef public size_t get_action_space_size(env):
@@ -41,10 +98,19 @@ cdef public cpp_pair[cpp_vector[float],cpp_vector[float]] execute_action(env, cp
     return cpp_pair[cpp_vector[float],cpp_vector[float]] (next_state, np.atleast_1d(rewards))
 
 
-def run(env, discount_factor=1.0, max_iterations=100, epsilon=0.01, verbose=True):
+def run(env, discount_factor=1.0, max_iterations=100, epsilon=0.01, verbose=True, engine="chvi"):
     assert isinstance(env.observation_space, gym.spaces.MultiDiscrete), "Only gym.spaces.MultiDiscrete observation spaces are supported"
     assert isinstance(env.action_space, gym.spaces.Discrete), "Only gym.spaces.Discrete action spaces are supported"
     assert 'state' in dir(env), 'Environment needs to store current state in an attribute called "state"'
     assert 'is_terminal' in dir(env), "Environment needs to provide an 'is_terminal(state)' method"
     assert isinstance(env.state, np.ndarray), "State attribute must be a np.ndarray"
-    return run_chvi(env, discount_factor, max_iterations, epsilon, verbose)
+    assert engine in ("chvi", "ols"), "Engine must be either 'chvi' (convex hull value iteration) or 'ols' (optimistic linear support)"
+    # the points of the hull of the i-th state are points[offsets[i]:offsets[i + 1]]
+    cdef _Offsets offsets = _Offsets()
+    cdef _Points points = _Points()
+    points.dimensions = len(env.observation_space.nvec)
+    if engine == "ols":
+        run_ols_csr(env, discount_factor, max_iterations, epsilon, verbose, offsets.data, points.data)
+    else:
+        run_chvi_csr(env, discount_factor, max_iterations, epsilon, verbose, offsets.data, points.data)
+    return np.asarray(offsets), np.asarray(points)
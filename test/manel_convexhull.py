@@ -14,6 +14,22 @@ def non_dominated(solutions, verbose=False):
     return solutions[is_efficient]
 
 
+def affine_hull_vertices(points, tolerance=1e-6):
+    # hull of points lying in a proper affine subspace (e.g., collinear or coplanar),
+    # computed in the coordinates of such subspace and lifted back to the input points
+    points = np.asarray(points)
+    centered = points - points[0]
+    scale = np.abs(centered).max()
+    if scale == 0:
+        return [points[0]]
+    _, s, vt = np.linalg.svd(centered, full_matrices=False)
+    basis = vt[s > tolerance * scale]
+    projected = centered @ basis.T
+    if len(basis) == 1:
+        return [points[np.argmin(projected[:, 0])], points[np.argmax(projected[:, 0])]]
+    return [points[vertex] for vertex in ConvexHull(projected).vertices]
+
+
 def get_hull(points, CCS=True):
     if CCS:
         points = non_dominated(np.array(points), verbose=True)
@@ -21,7 +37,10 @@ def get_hull(points, CCS=True):
         hull = ConvexHull(points)
         hull_points = [points[vertex] for vertex in hull.vertices]
     except:
-        hull_points = points
+        try:
+            hull_points = affine_hull_vertices(points)
+        except:
+            hull_points = points
     if CCS:
         vertices = non_dominated(np.array(hull_points))
     else:
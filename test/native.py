@@ -3,6 +3,7 @@
 from subprocess import PIPE
 import subprocess
 import numpy as np
+import tempfile
 import random
 import time
 import sys
@@ -121,7 +122,40 @@ if __name__ == "__main__":
             sps = f'{sp:.{width}f}'
             l1 = list_of_sets_of_tuples(python)
             l2 = list_of_sets_of_tuples(native, dimensions)
-            if l1 == l2:
+            # the weight-space engine only returns the convex coverage set of the initial state, whose upper
+            # surface must coincide with the one of the convex hull of the initial state at convergence (epsilon = 0)
+            output = subprocess.run(command_line[:-1] + ['-w', '-0'], check=True, stdout=PIPE, stderr=PIPE).stdout.decode().rstrip()
+            exec(f'ols = {output}')
+            converged = partial_convex_hull_value_iteration(
+                TestEnv(dimensions, size, int(seed)),
+                discount_factor=parameters["discount_factor"],
+                max_iterations=parameters["max_iterations"],
+                epsilon=0,
+                verbose=False
+            )
+            weights = np.random.dirichlet(np.ones(dimensions), size=parameters["n_weights"])
+            ccs = np.array(ols).reshape(-1, dimensions)
+            hull = np.array(converged[0]).reshape(-1, dimensions)
+            if len(ccs) > 0 and len(hull) > 0:
+                ols_surface = np.max(weights @ ccs.T, axis=1)
+                chvi_surface = np.max(weights @ hull.T, axis=1)
+                same_surface = np.allclose(ols_surface, chvi_surface, atol=parameters["weight_tolerance"])
+            else:
+                same_surface = len(ccs) == len(hull)
+            # a batch of configurations of the same environment must yield the same hulls as the single runs
+            batch = [(parameters["discount_factor"], parameters["epsilon"])] + parameters["batch_configurations"]
+            with tempfile.NamedTemporaryFile('w', suffix='.txt') as batch_file:
+                batch_file.write(''.join(f'{seed} {f} {e}\n' for (f, e) in batch))
+                batch_file.flush()
+                output = subprocess.run(command_line[:4] + [f'-i {parameters["max_iterations"]}', '-b', batch_file.name, '-o'],
+                                        check=True, stdout=PIPE, stderr=PIPE).stdout.decode().rstrip().split('\n')
+            single = [native]
+            for (f, e) in batch[1:]:
+                single_output = subprocess.run(command_line[:4] + [f'-f {f}', f'-i {parameters["max_iterations"]}', f'-e {e}', '-o'],
+                                               check=True, stdout=PIPE, stderr=PIPE).stdout.decode().rstrip()
+                exec(f'single.append({single_output})')
+            same_batch = [eval(o) for o in output] == single
+            if l1 == l2 and same_surface and same_batch:
                 progress.console.print(f'Testing seed {seed:>0{len(str(parameters["max_seed"]))}} (runtimes = {t1s[:width]} {t2s[:width]} speed-up = {sps[:width]}) [[bold green]PASSED[/]]')
                 progress.update(task, advance=1)
             else:
@@ -129,3 +163,7 @@ if __name__ == "__main__":
                 for (i, (a, b)) in enumerate(zip(l1, l2)):
                     if a != b:
                         print(f'{i}: {a} != {b}')
+                if not same_surface:
+                    print(f'weight-space: {sorted(map(tuple, ccs))} != {sorted(map(tuple, hull))}')
+                if not same_batch:
+                    print(f'batch: {output} != {single}')
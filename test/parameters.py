@@ -8,6 +8,11 @@ parameters = {
     "discount_factor": 1.0,
     "max_iterations": 100,
     "epsilon": 0.05,
+    # other (discount_factor, epsilon) configurations solved in batch with the one above
+    "batch_configurations": [(0.9, 0.05), (0.95, 0.01)],
+    # weight-space engine parameters
+    "n_weights": 1000,
+    "weight_tolerance": 1e-4,
     # tests parameters
     "seed": 12345,
     "n_tests": 100,